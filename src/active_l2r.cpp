@@ -15,7 +15,13 @@
  * Instances are chosen using uncertainty sampling where the measure of
  * uncertainty is the distance from the decision boundary. One instance at
  * a time is chosen, and the model is re-fit using the new training
- * instances.
+ * instances. Setting `strategy = "random"` instead adds a random pair at
+ * each step as a baseline.
+ *
+ * Each of `num-seeds`, `max-train-size`, and `strategy` may be an array,
+ * and `trials` controls how many differently-seeded runs are made of
+ * every combination. Use `--shard k/N` to run only part of this sweep;
+ * see sweep.h.
  */
 
 #include "cpptoml.h"
@@ -27,6 +33,7 @@
 #include "regression/regression_dataset_view.h"
 #include "util/progress.h"
 #include "util/shim.h"
+#include "sweep.h"
 
 using namespace meta;
 
@@ -57,24 +64,172 @@ std::pair<std::size_t, std::size_t> id_to_pair(std::size_t idx, std::size_t n)
     return {i, j};
 }
 
+/**
+ * A single cell of the sweep.
+ */
+struct experiment
+{
+    int64_t trial;
+    uint64_t seed;
+    std::string strategy;
+    int64_t num_seeds;
+    int64_t max_train_size;
+};
+
+/**
+ * Runs a single cell of the sweep, writing one line of its learning curve
+ * to `results` per step.
+ */
+void run_experiment(const experiment& exp,
+                    const regression::regression_dataset& reg_dset,
+                    const classify::binary_dataset& bin_dset,
+                    const std::vector<double>& reference_scores,
+                    std::ostream& results)
+{
+    // create a view and shuffle it
+    classify::binary_dataset_view bdv{bin_dset, std::mt19937_64{exp.seed}};
+    bdv.shuffle();
+
+    // select our seeds into the training set
+    classify::binary_dataset_view train{bdv, bdv.begin(),
+                                        bdv.begin() + exp.num_seeds};
+
+    auto max_train_size = static_cast<std::size_t>(exp.max_train_size);
+    printing::progress progress{" > Learning: ", bdv.size() - 1};
+    while (train.size() < bdv.size() && train.size() < max_train_size)
+    {
+        progress(train.size());
+        // train a linear SVM on our learning-to-rank reduction
+        classify::sgd svm{train, make_unique<learn::loss::hinge>(), {}};
+
+        // get scores for all instances in the original data
+        std::vector<double> system_scores;
+        system_scores.reserve(reg_dset.size());
+        std::transform(std::begin(reg_dset), std::end(reg_dset),
+                       std::back_inserter(system_scores),
+                       [&](const learn::instance& inst)
+                       {
+                           return svm.predict(inst.weights);
+                       });
+
+        std::unordered_set<std::size_t> used;
+        for (const auto& inst : train)
+        {
+            std::size_t x;
+            std::size_t y;
+            std::tie(x, y) = id_to_pair(inst.id, reg_dset.size());
+
+            used.insert(x);
+            used.insert(y);
+        }
+
+        // compute rank correlation measures
+        index::rank_correlation corr{system_scores, reference_scores};
+        results << exp.trial << "," << exp.strategy << ","
+                << exp.num_seeds << "," << exp.max_train_size << ","
+                << train.size() << "," << used.size() << ","
+                << corr.ndpm() << "\n";
+
+        auto test = bdv - train;
+        if (exp.strategy == "random")
+        {
+            // add a random point to the training set
+            test.shuffle();
+            train.add_by_index(test.begin().index());
+            continue;
+        }
+
+        // update training set to include least confident pairwise
+        // example in the "unlabeled" data
+        auto it = std::min_element(
+            std::begin(test), std::end(test),
+            [&](const learn::instance& lhs, const learn::instance& rhs)
+            {
+                return std::abs(svm.predict(lhs.weights))
+                       < std::abs(svm.predict(rhs.weights));
+            });
+
+        train.add_by_index(it.index());
+    }
+}
+
 int main(int argc, char** argv)
 {
     logging::set_cerr_logging();
-    if (argc < 2)
+    auto cmd = meded::parse_command_line(argc, argv, "results.csv");
+    if (!cmd)
     {
-        std::cerr << "Usage: " << argv[0] << " config.toml" << std::endl;
+        std::cerr << meded::usage(argv[0]) << std::endl;
         return 1;
     }
 
-    auto config = cpptoml::parse_file(argv[1]);
-    auto f_idx = index::make_index<index::forward_index>(*config);
+    auto config = cpptoml::parse_file(cmd->config);
+    if (cmd->index_only)
+    {
+        index::make_index<index::forward_index>(*config);
+        return 0;
+    }
 
     auto al_config = config->get_table("active-learning");
-    auto num_seeds = al_config->get_as<int64_t>("num-seeds").value_or(1);
-    auto max_train_size = static_cast<std::size_t>(
-        al_config->get_as<int64_t>("max-train-size").value_or(1000));
+    auto trials = al_config->get_as<int64_t>("trials").value_or(1);
+    auto strategies
+        = meded::sweep_axis<std::string>(*al_config, "strategy", "uncertainty");
+    auto seed_counts = meded::sweep_axis<int64_t>(*al_config, "num-seeds", 1);
+    auto max_train_sizes
+        = meded::sweep_axis<int64_t>(*al_config, "max-train-size", 1000);
 
+    if (!meded::check_axis("trials", std::vector<int64_t>{trials}, 1)
+        || !meded::check_axis("strategy", strategies)
+        || !meded::check_axis("num-seeds", seed_counts, 1)
+        || !meded::check_axis("max-train-size", max_train_sizes, 1))
+        return 1;
+
+    for (const auto& strategy : strategies)
+    {
+        if (strategy != "uncertainty" && strategy != "random")
+        {
+            std::cerr << "Unknown strategy: " << strategy << std::endl;
+            return 1;
+        }
+    }
+
+    // enumerate the sweep; this process only runs the cells in its shard
+    std::vector<experiment> experiments;
+    std::size_t cell = 0;
+    for (int64_t trial = 0; trial < trials; ++trial)
+        for (const auto& strategy : strategies)
+            for (auto num_seeds : seed_counts)
+                for (auto max_train_size : max_train_sizes)
+                    if (cmd->shard.contains(cell++))
+                        experiments.push_back(
+                            {trial, meded::trial_seed(*al_config, trial),
+                             strategy, num_seeds, max_train_size});
+
+    std::ofstream results{cmd->output};
+    if (!results)
+    {
+        std::cerr << "Failed to open " << cmd->output << std::endl;
+        return 1;
+    }
+    results << "trial,strategy,num-seeds,max-train-size,"
+               "training-size,num-distinct,NDPM\n";
+    if (experiments.empty())
+        return 0;
+
+    auto f_idx = index::make_index<index::forward_index>(*config);
     std::cout << "num instances: " << f_idx->num_docs() << std::endl;
+
+    // the seeds are pairs, so there can be at most n(n - 1)/2 of them
+    auto num_pairs = f_idx->num_docs() * (f_idx->num_docs() - 1) / 2;
+    for (auto num_seeds : seed_counts)
+    {
+        if (static_cast<uint64_t>(num_seeds) > num_pairs)
+        {
+            std::cerr << "num-seeds " << num_seeds << " is more than the "
+                      << num_pairs << " pairs of instances" << std::endl;
+            return 1;
+        }
+    }
     auto doc_rng = util::range(0_did, doc_id{f_idx->num_docs() - 1});
 
     // load the dataset in as a regression dataset
@@ -126,67 +281,12 @@ int main(int argc, char** argv)
                                           return inst.label;
                                       }};
 
-    // create a view and shuffle it
-    classify::binary_dataset_view bdv{bin_dset};
-    bdv.shuffle();
-
-    // select our seeds into the training set
-    classify::binary_dataset_view train{bdv, bdv.begin(),
-                                        bdv.begin() + num_seeds};
-
-    printing::progress progress{" > Learning: ", bdv.size() - 1};
-    std::ofstream results{"results.csv"};
-    results << "training-size,num-distinct,NDPM\n";
-    while (train.size() < bdv.size() && train.size() < max_train_size)
+    for (const auto& exp : experiments)
     {
-        progress(train.size());
-        // train a linear SVM on our learning-to-rank reduction
-        classify::sgd svm{train, make_unique<learn::loss::hinge>(), {}};
-
-        // get scores for all instances in the original data
-        std::vector<double> system_scores;
-        system_scores.reserve(reg_dset.size());
-        std::transform(std::begin(reg_dset), std::end(reg_dset),
-                       std::back_inserter(system_scores),
-                       [&](const learn::instance& inst)
-                       {
-                           return svm.predict(inst.weights);
-                       });
-
-        std::unordered_set<std::size_t> used;
-        for (const auto& inst : train)
-        {
-            std::size_t x;
-            std::size_t y;
-            std::tie(x, y) = id_to_pair(inst.id, reg_dset.size());
-
-            used.insert(x);
-            used.insert(y);
-        }
-
-        // compute rank correlation measures
-        index::rank_correlation corr{system_scores, reference_scores};
-        results << train.size() << "," << used.size()
-                << "," << corr.ndpm() << "\n";
-
-        auto test = bdv - train;
-#if 1
-        // update training set to include least confident pairwise example
-        // in the "unlabeled" data
-        auto it = std::min_element(
-            std::begin(test), std::end(test),
-            [&](const learn::instance& lhs, const learn::instance& rhs)
-            {
-                return std::abs(svm.predict(lhs.weights))
-                       < std::abs(svm.predict(rhs.weights));
-            });
-#else
-        // add a random point to the training set
-        test.shuffle();
-        auto it = test.begin();
-#endif
-
-        train.add_by_index(it.index());
+        std::cout << "trial " << exp.trial << ", " << exp.strategy
+                  << ", num-seeds " << exp.num_seeds << ", max-train-size "
+                  << exp.max_train_size << std::endl;
+        run_experiment(exp, reg_dset, bin_dset, reference_scores, results);
     }
 
     return 0;
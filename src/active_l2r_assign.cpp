@@ -15,6 +15,17 @@
  * The supervision provided by the teacher, however, is now a real-valued
  * grade on an *assignment* basis, as opposed to a pairwise comparison
  * judgment.
+ *
+ * The next assignment to grade is chosen by `strategy`: "min-pair" picks
+ * the ungraded assignment with the least confident pair against any
+ * graded one, "total" the one with the lowest total confidence across
+ * those pairs, "least-confident-pair" grades both assignments of the
+ * least confident pair, and "random" picks one at random.
+ *
+ * Each of `num-seeds`, `max-train-size`, and `strategy` may be an array,
+ * and `trials` controls how many differently-seeded runs are made of
+ * every combination. Use `--shard k/N` to run only part of this sweep;
+ * see sweep.h.
  */
 
 #include <cassert>
@@ -28,6 +39,7 @@
 #include "regression/regression_dataset_view.h"
 #include "util/progress.h"
 #include "util/shim.h"
+#include "sweep.h"
 
 using namespace meta;
 
@@ -58,90 +70,66 @@ std::pair<std::size_t, std::size_t> id_to_pair(std::size_t idx, std::size_t n)
     return {i, j};
 }
 
-int main(int argc, char** argv)
+/**
+ * Adds assignment `idx` to the graded assignments, along with every pair
+ * it forms with the assignments that were already graded.
+ */
+void add_assignment(classify::binary_dataset_view& train,
+                    regression::regression_dataset_view& train_rdv,
+                    std::size_t idx, std::size_t n)
 {
-    logging::set_cerr_logging();
-    if (argc < 2)
+    for (auto it = train_rdv.begin(); it != train_rdv.end(); ++it)
     {
-        std::cerr << "Usage: " << argv[0] << " config.toml" << std::endl;
-        return 1;
-    }
-
-    auto config = cpptoml::parse_file(argv[1]);
-    auto f_idx = index::make_index<index::forward_index>(*config);
-
-    auto al_config = config->get_table("active-learning-assign");
-    auto num_seeds = al_config->get_as<int64_t>("num-seeds").value_or(5);
-    auto max_train_size = static_cast<std::size_t>(
-        al_config->get_as<int64_t>("max-train-size").value_or(50));
-
-    auto doc_rng = util::range(0_did, doc_id{f_idx->num_docs() - 1});
-
-    // load the dataset in as a regression dataset
-    regression::regression_dataset reg_dset{
-        f_idx, [&](doc_id did)
-        {
-            return *f_idx->metadata(did).get<double>("response");
-        }};
-
-    std::vector<double> reference_scores;
-    reference_scores.reserve(reg_dset.size());
-    std::transform(std::begin(reg_dset), std::end(reg_dset),
-                   std::back_inserter(reference_scores),
-                   [&](const learn::instance& inst)
-                   {
-                       return reg_dset.label(inst);
-                   });
-
-    // convert it to a binary ranking dataset by making a new instance for
-    // every pair in the original
-    struct binary_instance
-    {
-        learn::feature_vector weights;
-        bool label;
-    };
-    std::vector<binary_instance> binary_instances;
-    binary_instances.reserve(reg_dset.size() / 2 * (reg_dset.size() - 1));
-    for (auto i = reg_dset.begin(); i != reg_dset.end(); ++i)
-    {
-        for (auto j = i + 1; j != reg_dset.end(); ++j)
-        {
-            auto label_diff = reg_dset.label(*i) - reg_dset.label(*j);
-            binary_instances.push_back(
-                {i->weights - j->weights, label_diff > 0});
-        }
+        if (it.index() < idx)
+            train.add_by_index(pair_to_id(it.index(), idx, n));
+        else
+            train.add_by_index(pair_to_id(idx, it.index(), n));
     }
+    train_rdv.add_by_index(idx);
+}
 
-    // construct the binary dataset from our transformation above
-    // I *could* do this more intelligently, but it's not worth it here
-    classify::binary_dataset bin_dset{std::begin(binary_instances),
-                                      std::end(binary_instances),
-                                      reg_dset.total_features(),
-                                      [](binary_instance& inst)
-                                      {
-                                          return std::move(inst.weights);
-                                      },
-                                      [](binary_instance& inst)
-                                      {
-                                          return inst.label;
-                                      }};
+/**
+ * A single cell of the sweep.
+ */
+struct experiment
+{
+    int64_t trial;
+    uint64_t seed;
+    std::string strategy;
+    int64_t num_seeds;
+    int64_t max_train_size;
+};
 
+/**
+ * Runs a single cell of the sweep: starts from the pairs among
+ * `num-seeds` randomly chosen assignments and grows the set of graded
+ * assignments until it reaches `max-train-size`, writing one line of the
+ * learning curve to `results` per step.
+ */
+void run_experiment(const experiment& exp,
+                    const regression::regression_dataset& reg_dset,
+                    const classify::binary_dataset& bin_dset,
+                    const std::vector<double>& reference_scores,
+                    std::ostream& results)
+{
     // create a view over the original assignments and shuffle it to select
     // our seeds
-    regression::regression_dataset_view rdv{reg_dset};
+    regression::regression_dataset_view rdv{reg_dset,
+                                            std::mt19937_64{exp.seed}};
     rdv.shuffle();
 
-    // create a view, DO NOT SHUFFLE
-    classify::binary_dataset_view bdv{bin_dset};
+    // create a view, DO NOT SHUFFLE; it is still seeded because the views
+    // made from it (and the sgd that trains on them) shuffle
+    classify::binary_dataset_view bdv{bin_dset, std::mt19937_64{exp.seed}};
 
     // create an empty view for the training set
     classify::binary_dataset_view train{bdv, bdv.end(), bdv.end()};
     regression::regression_dataset_view train_rdv{rdv, rdv.end(), rdv.end()};
 
     // insert all of the pairs from the seeds into the training set
-    for (auto i = rdv.begin(); i != rdv.begin() + num_seeds; ++i)
+    for (auto i = rdv.begin(); i != rdv.begin() + exp.num_seeds; ++i)
     {
-        for (auto j = i + 1; j != rdv.begin() + num_seeds; ++j)
+        for (auto j = i + 1; j != rdv.begin() + exp.num_seeds; ++j)
         {
             if (i.index() < j.index())
             {
@@ -156,12 +144,11 @@ int main(int argc, char** argv)
         }
         train_rdv.add_by_index(i.index());
     }
-    assert(train_rdv.size() == num_seeds);
-    assert(train.size() == num_seeds * (num_seeds - 1) / 2);
+    assert(train_rdv.size() == exp.num_seeds);
+    assert(train.size() == exp.num_seeds * (exp.num_seeds - 1) / 2);
 
+    auto max_train_size = static_cast<std::size_t>(exp.max_train_size);
     printing::progress progress{" > Learning: ", bdv.size() - 1};
-    std::ofstream results{"results-assign.csv"};
-    results << "training-size,num-graded,NDPM\n";
     while (train_rdv.size() < rdv.size() && train_rdv.size() < max_train_size)
     {
         progress(train.size());
@@ -180,144 +167,242 @@ int main(int argc, char** argv)
 
         // compute rank correlation measures
         index::rank_correlation corr{system_scores, reference_scores};
-        results << train.size() << "," << train_rdv.size() << "," << corr.ndpm()
-                << "\n";
+        results << exp.trial << "," << exp.strategy << "," << exp.num_seeds
+                << "," << exp.max_train_size << "," << train.size() << ","
+                << train_rdv.size() << "," << corr.ndpm() << "\n";
 
         auto unlabled = rdv - train_rdv;
         assert(unlabled.size() + train_rdv.size() == rdv.size());
 
-#if 0
-        std::vector<double> scores;
-        scores.reserve(unlabled.size());
-#if 0
-        // update the training set to include the assignment from the
-        // unlabeled data that has the lowest confidence pair against any
-        // assignment in the labeled data
-        std::transform(
-            std::begin(unlabled), std::end(unlabled),
-            std::back_inserter(scores), [&](const learn::instance& inst)
+        if (exp.strategy == "min-pair" || exp.strategy == "total")
+        {
+            std::vector<double> scores;
+            scores.reserve(unlabled.size());
+            if (exp.strategy == "min-pair")
             {
-                auto it = std::min_element(
-                    std::begin(train_rdv), std::end(train_rdv),
-                    [&](const learn::instance& lhs, const learn::instance& rhs)
+                // update the training set to include the assignment from
+                // the unlabeled data that has the lowest confidence pair
+                // against any assignment in the labeled data
+                std::transform(
+                    std::begin(unlabled), std::end(unlabled),
+                    std::back_inserter(scores),
+                    [&](const learn::instance& inst)
                     {
-                        return std::abs(svm.predict(inst.weights - lhs.weights))
-                               < std::abs(
-                                     svm.predict(inst.weights - rhs.weights));
+                        auto it = std::min_element(
+                            std::begin(train_rdv), std::end(train_rdv),
+                            [&](const learn::instance& lhs,
+                                const learn::instance& rhs)
+                            {
+                                return std::abs(svm.predict(inst.weights
+                                                            - lhs.weights))
+                                       < std::abs(svm.predict(
+                                             inst.weights - rhs.weights));
+                            });
+                        return std::abs(
+                            svm.predict(inst.weights - it->weights));
                     });
-                return std::abs(svm.predict(inst.weights - it->weights));
-            });
-#else
-        // update the training set to include the assignment from the
-        // unlabeled data that has the lowest confidence total across all
-        // pairs it would form with assignments in the labeled data
-        std::transform(
-            std::begin(unlabled), std::end(unlabled),
-            std::back_inserter(scores), [&](const learn::instance& inst)
+            }
+            else
             {
-                return std::accumulate(
-                    std::begin(train_rdv), std::end(train_rdv), 0.0,
-                    [&](double accum, const learn::instance& other)
+                // update the training set to include the assignment from
+                // the unlabeled data that has the lowest confidence total
+                // across all pairs it would form with assignments in the
+                // labeled data
+                std::transform(
+                    std::begin(unlabled), std::end(unlabled),
+                    std::back_inserter(scores),
+                    [&](const learn::instance& inst)
                     {
-                        return accum + std::abs(svm.predict(inst.weights
-                                                            - other.weights));
+                        return std::accumulate(
+                            std::begin(train_rdv), std::end(train_rdv), 0.0,
+                            [&](double accum, const learn::instance& other)
+                            {
+                                return accum
+                                       + std::abs(svm.predict(
+                                             inst.weights - other.weights));
+                            });
                     });
-            });
-#endif
-
-        auto it = std::min_element(std::begin(scores), std::end(scores));
-        auto diff = it - std::begin(scores);
-        auto inst_it = unlabled.begin() + diff;
+            }
 
-        for (auto it = train_rdv.begin(); it != train_rdv.end(); ++it)
+            auto it = std::min_element(std::begin(scores), std::end(scores));
+            auto diff = it - std::begin(scores);
+            auto inst_it = unlabled.begin() + diff;
+            add_assignment(train, train_rdv, inst_it.index(), rdv.size());
+        }
+        else if (exp.strategy == "least-confident-pair")
         {
-            if (it.index() < inst_it.index())
-            {
-                train.add_by_index(
-                    pair_to_id(it.index(), inst_it.index(), rdv.size()));
-            }
-            else
-            {
-                train.add_by_index(
-                    pair_to_id(inst_it.index(), it.index(), rdv.size()));
-            }
+            // update the training set to include the pair of assignments
+            // that is least confident under the current model
+            //
+            // this may add either one or two assignments to the training
+            // data
+            auto test = bdv - train;
+            auto it = std::min_element(
+                std::begin(test), std::end(test),
+                [&](const learn::instance& lhs, const learn::instance& rhs)
+                {
+                    return std::abs(svm.predict(lhs.weights))
+                           < std::abs(svm.predict(rhs.weights));
+                });
+
+            std::size_t x;
+            std::size_t y;
+            std::tie(x, y) = id_to_pair(it.index(), rdv.size());
+            assert(pair_to_id(x, y, rdv.size()) == it.index());
+
+            std::unordered_set<std::size_t> used;
+            for (const auto& inst : train_rdv)
+                used.insert(inst.id);
+
+            if (used.find(x) == used.end())
+                add_assignment(train, train_rdv, x, rdv.size());
+            if (used.find(y) == used.end())
+                add_assignment(train, train_rdv, y, rdv.size());
         }
-        train_rdv.add_by_index(inst_it.index());
-#elif 0
-        // update the training set to include the pair of assignments that
-        // is least confident under the current model
-        //
-        // this may add either one or two assignments to the training data
-
-        auto test = bdv - train;
-        auto it = std::min_element(
-            std::begin(test), std::end(test),
-            [&](const learn::instance& lhs, const learn::instance& rhs)
-            {
-                return std::abs(svm.predict(lhs.weights))
-                       < std::abs(svm.predict(rhs.weights));
-            });
+        else
+        {
+            // randomly add a new question to the training set
+            auto test = rdv - train_rdv;
+            test.shuffle();
+            add_assignment(train, train_rdv, test.begin().index(),
+                           rdv.size());
+        }
+    }
+}
 
-        std::size_t x;
-        std::size_t y;
-        std::tie(x, y) = id_to_pair(it.index(), rdv.size());
-        assert(pair_to_id(x, y, rdv.size()) == it.index());
+int main(int argc, char** argv)
+{
+    logging::set_cerr_logging();
+    auto cmd = meded::parse_command_line(argc, argv, "results-assign.csv");
+    if (!cmd)
+    {
+        std::cerr << meded::usage(argv[0]) << std::endl;
+        return 1;
+    }
 
-        std::unordered_set<std::size_t> used;
-        for (const auto& inst : train_rdv)
-            used.insert(inst.id);
+    auto config = cpptoml::parse_file(cmd->config);
+    if (cmd->index_only)
+    {
+        index::make_index<index::forward_index>(*config);
+        return 0;
+    }
+
+    auto al_config = config->get_table("active-learning-assign");
+    auto trials = al_config->get_as<int64_t>("trials").value_or(1);
+    auto strategies
+        = meded::sweep_axis<std::string>(*al_config, "strategy", "random");
+    auto seed_counts = meded::sweep_axis<int64_t>(*al_config, "num-seeds", 5);
+    auto max_train_sizes
+        = meded::sweep_axis<int64_t>(*al_config, "max-train-size", 50);
+
+    // at least two graded assignments are needed to form a pair
+    if (!meded::check_axis("trials", std::vector<int64_t>{trials}, 1)
+        || !meded::check_axis("strategy", strategies)
+        || !meded::check_axis("num-seeds", seed_counts, 2)
+        || !meded::check_axis("max-train-size", max_train_sizes, 1))
+        return 1;
 
-        if (used.find(x) == used.end())
+    for (const auto& strategy : strategies)
+    {
+        if (strategy != "min-pair" && strategy != "total"
+            && strategy != "least-confident-pair" && strategy != "random")
         {
-            for (auto it = train_rdv.begin(); it != train_rdv.end(); ++it)
-            {
-                if (it.index() < x)
-                {
-                    train.add_by_index(pair_to_id(it.index(), x, rdv.size()));
-                }
-                else
-                {
-                    train.add_by_index(pair_to_id(x, it.index(), rdv.size()));
-                }
-            }
-            train_rdv.add_by_index(x);
+            std::cerr << "Unknown strategy: " << strategy << std::endl;
+            return 1;
         }
+    }
+
+    // enumerate the sweep; this process only runs the cells in its shard
+    std::vector<experiment> experiments;
+    std::size_t cell = 0;
+    for (int64_t trial = 0; trial < trials; ++trial)
+        for (const auto& strategy : strategies)
+            for (auto num_seeds : seed_counts)
+                for (auto max_train_size : max_train_sizes)
+                    if (cmd->shard.contains(cell++))
+                        experiments.push_back(
+                            {trial, meded::trial_seed(*al_config, trial),
+                             strategy, num_seeds, max_train_size});
+
+    std::ofstream results{cmd->output};
+    if (!results)
+    {
+        std::cerr << "Failed to open " << cmd->output << std::endl;
+        return 1;
+    }
+    results << "trial,strategy,num-seeds,max-train-size,"
+               "training-size,num-graded,NDPM\n";
+    if (experiments.empty())
+        return 0;
 
-        if (used.find(y) == used.end())
+    auto f_idx = index::make_index<index::forward_index>(*config);
+    for (auto num_seeds : seed_counts)
+    {
+        if (static_cast<uint64_t>(num_seeds) > f_idx->num_docs())
         {
-            for (auto it = train_rdv.begin(); it != train_rdv.end(); ++it)
-            {
-                if (it.index() < y)
-                {
-                    train.add_by_index(pair_to_id(it.index(), y, rdv.size()));
-                }
-                else
-                {
-                    train.add_by_index(pair_to_id(y, it.index(), rdv.size()));
-                }
-            }
-            train_rdv.add_by_index(y);
+            std::cerr << "num-seeds " << num_seeds << " is more than the "
+                      << f_idx->num_docs() << " assignments" << std::endl;
+            return 1;
         }
-#else
-        // randomly add a new question to the training set
-        auto test = rdv - train_rdv;
-        test.shuffle();
+    }
+
+    auto doc_rng = util::range(0_did, doc_id{f_idx->num_docs() - 1});
 
-        for (auto it = train_rdv.begin(); it != train_rdv.end(); ++it)
+    // load the dataset in as a regression dataset
+    regression::regression_dataset reg_dset{
+        f_idx, [&](doc_id did)
         {
-            if (it.index() < test.begin().index())
-            {
-                train.add_by_index(
-                    pair_to_id(it.index(), test.begin().index(), rdv.size()));
-            }
-            else
-            {
-                train.add_by_index(
-                    pair_to_id(test.begin().index(), it.index(), rdv.size()));
-            }
+            return *f_idx->metadata(did).get<double>("response");
+        }};
+
+    std::vector<double> reference_scores;
+    reference_scores.reserve(reg_dset.size());
+    std::transform(std::begin(reg_dset), std::end(reg_dset),
+                   std::back_inserter(reference_scores),
+                   [&](const learn::instance& inst)
+                   {
+                       return reg_dset.label(inst);
+                   });
+
+    // convert it to a binary ranking dataset by making a new instance for
+    // every pair in the original
+    struct binary_instance
+    {
+        learn::feature_vector weights;
+        bool label;
+    };
+    std::vector<binary_instance> binary_instances;
+    binary_instances.reserve(reg_dset.size() / 2 * (reg_dset.size() - 1));
+    for (auto i = reg_dset.begin(); i != reg_dset.end(); ++i)
+    {
+        for (auto j = i + 1; j != reg_dset.end(); ++j)
+        {
+            auto label_diff = reg_dset.label(*i) - reg_dset.label(*j);
+            binary_instances.push_back(
+                {i->weights - j->weights, label_diff > 0});
         }
-        train_rdv.add_by_index(std::begin(test).index());
-#endif
+    }
+
+    // construct the binary dataset from our transformation above
+    // I *could* do this more intelligently, but it's not worth it here
+    classify::binary_dataset bin_dset{std::begin(binary_instances),
+                                      std::end(binary_instances),
+                                      reg_dset.total_features(),
+                                      [](binary_instance& inst)
+                                      {
+                                          return std::move(inst.weights);
+                                      },
+                                      [](binary_instance& inst)
+                                      {
+                                          return inst.label;
+                                      }};
+
+    for (const auto& exp : experiments)
+    {
+        std::cout << "trial " << exp.trial << ", " << exp.strategy
+                  << ", num-seeds " << exp.num_seeds << ", max-train-size "
+                  << exp.max_train_size << std::endl;
+        run_experiment(exp, reg_dset, bin_dset, reference_scores, results);
     }
 
     return 0;
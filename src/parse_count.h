@@ -0,0 +1,37 @@
+/**
+ * @file parse_count.h
+ *
+ * Parses the counts given on the command line of the sweep executables.
+ * This has no dependencies so that sweep_coordinator.cpp, which doesn't
+ * link against MeTA, can share it with sweep.h.
+ */
+
+#ifndef MEDED_PARSE_COUNT_H_
+#define MEDED_PARSE_COUNT_H_
+
+#include <cerrno>
+#include <cstdlib>
+#include <limits>
+#include <string>
+
+namespace meded
+{
+
+/**
+ * Parses a non-negative integer, rejecting anything that isn't all digits
+ * or doesn't fit in a std::size_t.
+ */
+inline bool parse_count(const std::string& str, std::size_t& count)
+{
+    if (str.empty() || str.find_first_not_of("0123456789") != std::string::npos)
+        return false;
+
+    errno = 0;
+    auto val = std::strtoull(str.c_str(), nullptr, 10);
+    if (errno == ERANGE || val > std::numeric_limits<std::size_t>::max())
+        return false;
+    count = static_cast<std::size_t>(val);
+    return true;
+}
+}
+#endif
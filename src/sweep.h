@@ -0,0 +1,200 @@
+/**
+ * @file sweep.h
+ *
+ * Helpers shared by the active learning executables for running a slice
+ * of an experiment sweep. The sweep is the cartesian product of every
+ * configured trial, strategy, number of seeds, and maximum training set
+ * size; each element of that product is a *cell*. Passing `--shard k/N`
+ * restricts a process to the cells whose index is congruent to \f$k - 1\f$
+ * modulo \f$N\f$, so \f$N\f$ processes (possibly on different machines)
+ * together cover the whole sweep. See sweep_coordinator.cpp for a driver.
+ */
+
+#ifndef MEDED_SWEEP_H_
+#define MEDED_SWEEP_H_
+
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "cpptoml.h"
+#include "util/optional.h"
+#include "parse_count.h"
+
+namespace meded
+{
+
+/**
+ * Which slice of the sweep a process is responsible for. The index is
+ * 1-based to match the `--shard k/N` syntax.
+ */
+struct shard_spec
+{
+    std::size_t index = 1;
+    std::size_t count = 1;
+
+    bool contains(std::size_t cell) const
+    {
+        return cell % count == index - 1;
+    }
+};
+
+/**
+ * The options accepted by the active learning executables.
+ */
+struct command_line
+{
+    std::string config;
+    std::string output;
+    shard_spec shard;
+    bool index_only = false;
+};
+
+/**
+ * Parses a shard specification of the form "k/N" with \f$1 \le k \le N\f$.
+ */
+inline meta::util::optional<shard_spec> parse_shard(const std::string& spec)
+{
+    auto slash = spec.find('/');
+    if (slash == std::string::npos)
+        return meta::util::nullopt;
+
+    shard_spec shard;
+    if (!parse_count(spec.substr(0, slash), shard.index)
+        || !parse_count(spec.substr(slash + 1), shard.count))
+        return meta::util::nullopt;
+
+    if (shard.index < 1 || shard.index > shard.count)
+        return meta::util::nullopt;
+    return shard;
+}
+
+/**
+ * Parses `config.toml [--shard k/N] [--output file.csv] [--index-only]`.
+ * When no output file is given, the default name is used, suffixed with
+ * the shard when the sweep is split. `--index-only` just builds the index
+ * (if needed) and exits, so that a coordinator can make sure it exists
+ * before starting several workers that would otherwise all try to build
+ * it at once.
+ */
+inline meta::util::optional<command_line>
+    parse_command_line(int argc, char** argv, const std::string& default_output)
+{
+    if (argc < 2)
+        return meta::util::nullopt;
+
+    command_line cmd;
+    cmd.config = argv[1];
+    for (int i = 2; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg == "--index-only")
+        {
+            cmd.index_only = true;
+            continue;
+        }
+
+        if (i + 1 == argc)
+            return meta::util::nullopt;
+
+        if (arg == "--shard")
+        {
+            auto shard = parse_shard(argv[++i]);
+            if (!shard)
+                return meta::util::nullopt;
+            cmd.shard = *shard;
+        }
+        else if (arg == "--output")
+        {
+            cmd.output = argv[++i];
+        }
+        else
+        {
+            return meta::util::nullopt;
+        }
+    }
+
+    if (cmd.output.empty())
+    {
+        cmd.output = default_output;
+        if (cmd.shard.count > 1)
+        {
+            auto ext = cmd.output.rfind(".csv");
+            cmd.output.insert(ext == std::string::npos ? cmd.output.size()
+                                                       : ext,
+                              "-" + std::to_string(cmd.shard.index) + "-of-"
+                                  + std::to_string(cmd.shard.count));
+        }
+    }
+    return cmd;
+}
+
+inline std::string usage(const char* prog)
+{
+    return std::string{"Usage: "} + prog
+           + " config.toml [--shard k/N] [--output file.csv] [--index-only]";
+}
+
+/**
+ * Reads a sweep axis that may be given either as a single value or as an
+ * array of values.
+ */
+template <class T>
+std::vector<T> sweep_axis(const cpptoml::table& config, const std::string& key,
+                          T default_value)
+{
+    if (auto arr = config.get_array_of<T>(key))
+        return *arr;
+    return {config.get_as<T>(key).value_or(default_value)};
+}
+
+/**
+ * Checks that a sweep axis has at least one value, printing an error if
+ * it doesn't.
+ */
+template <class T>
+bool check_axis(const std::string& key, const std::vector<T>& values)
+{
+    if (values.empty())
+    {
+        std::cerr << key << " must have at least one value" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Checks that a numeric sweep axis has at least one value and that every
+ * value is at least `min`, printing an error if not.
+ */
+inline bool check_axis(const std::string& key,
+                       const std::vector<int64_t>& values, int64_t min)
+{
+    if (!check_axis<int64_t>(key, values))
+        return false;
+
+    for (auto val : values)
+    {
+        if (val < min)
+        {
+            std::cerr << key << " must be at least " << min << ", not " << val
+                      << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * The random seed for a given trial. Every process in a sweep must agree
+ * on this (and a retried cell must reproduce its results), so the base
+ * seed comes from the config file rather than from std::random_device.
+ */
+inline uint64_t trial_seed(const cpptoml::table& config, int64_t trial)
+{
+    auto seed = config.get_as<int64_t>("seed").value_or(47);
+    return static_cast<uint64_t>(seed + trial);
+}
+}
+#endif
@@ -0,0 +1,904 @@
+/**
+ * @file sweep_coordinator.cpp
+ *
+ * This file runs an experiment sweep by splitting it into shards and
+ * running each one as a separate worker process, e.g.
+ *
+ *     sweep-coordinator --shards 16 --jobs 4 ./active-l2r config.toml
+ *
+ * runs `./active-l2r config.toml --shard k/16` for every k, four at a
+ * time. Work is handed out through a queue directory (`--queue`, default
+ * "sweep") using one claim file per shard, created with O_EXCL so that
+ * only one coordinator runs a shard at a time. Several coordinators on
+ * different machines may share the same queue directory over a shared
+ * filesystem to spread the sweep out.
+ *
+ * A shard whose worker exits unsuccessfully (or is killed) is released
+ * and retried, up to `--retries` times; after that it is marked with a
+ * `.failed` file. Removing that file by hand gives the shard a fresh set
+ * of retries.
+ *
+ * While a worker runs, its coordinator keeps touching the claim file. A
+ * claim that has not been touched for `--lease` seconds (default 300) is
+ * assumed to belong to a dead coordinator and is taken over by renaming
+ * it out of the way, which only one coordinator can do, before creating a
+ * new one. A claim held by a coordinator on the same machine that no
+ * longer exists is taken over without waiting for the lease, and an
+ * interrupted coordinator (SIGINT or SIGTERM) stops its workers and
+ * releases its claims before exiting.
+ * A coordinator that finds its claim has been taken over stops its
+ * worker. Each attempt writes to its own temporary file, and every cell
+ * of the sweep is seeded from the config file, so a shard that happens
+ * to be run twice produces the same results either time.
+ *
+ * Before starting any workers, a coordinator makes sure the index exists
+ * by running `executable config.toml --index-only` once per queue.
+ *
+ * The queue directory records which executable, config file (and its
+ * contents), and number of shards it was created for; a coordinator
+ * refuses to run or merge a sweep that doesn't match.
+ *
+ * Once every shard has finished, the per-shard CSVs are concatenated into
+ * `results.csv` in the queue directory and averaged over the `trial`
+ * column into `curves.csv`: rows are grouped by every column up to and
+ * including `training-size`, and the mean and standard deviation across
+ * trials are reported for every column after it.
+ */
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <csignal>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <utime.h>
+
+#include "parse_count.h"
+
+struct options
+{
+    std::string executable;
+    std::string config;
+    std::string queue = "sweep";
+    std::size_t shards = 0;
+    std::size_t jobs = 1;
+    std::size_t retries = 2;
+    std::time_t lease = 300;
+    bool merge_only = false;
+};
+
+bool parse_options(int argc, char** argv, options& opts)
+{
+    std::vector<std::string> positional;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg == "--merge-only")
+        {
+            opts.merge_only = true;
+            continue;
+        }
+
+        if (arg.compare(0, 2, "--") != 0)
+        {
+            positional.push_back(arg);
+            continue;
+        }
+
+        if (i + 1 == argc)
+            return false;
+        std::string val = argv[++i];
+        if (arg == "--queue")
+        {
+            opts.queue = val;
+            continue;
+        }
+
+        std::size_t num;
+        if (!meded::parse_count(val, num))
+            return false;
+        if (arg == "--shards")
+            opts.shards = num;
+        else if (arg == "--jobs")
+            opts.jobs = num;
+        else if (arg == "--retries")
+            opts.retries = num;
+        else if (arg == "--lease")
+            opts.lease = static_cast<std::time_t>(num);
+        else
+            return false;
+    }
+
+    if (opts.shards == 0 || opts.jobs == 0)
+        return false;
+    if (positional.size() != 2)
+        return false;
+    opts.executable = positional[0];
+    opts.config = positional[1];
+    return true;
+}
+
+/**
+ * The files in the queue directory that belong to a single shard.
+ */
+struct shard_files
+{
+    shard_files(const std::string& queue, std::size_t k)
+    {
+        auto base = queue + "/shard-" + std::to_string(k);
+        claim = base + ".claim";
+        attempts = base + ".attempts";
+        failed = base + ".failed";
+        log = base + ".log";
+        results = base + ".csv";
+    }
+
+    std::string claim;
+    std::string attempts;
+    std::string failed;
+    std::string log;
+    std::string results;
+};
+
+bool exists(const std::string& path)
+{
+    struct stat st;
+    return ::stat(path.c_str(), &st) == 0;
+}
+
+/**
+ * Identifies this coordinator in claim files and in the names of its
+ * temporary files.
+ */
+std::string hostname()
+{
+    char host[256] = {};
+    ::gethostname(host, sizeof(host) - 1);
+    return host;
+}
+
+const std::string& owner()
+{
+    static const std::string who
+        = hostname() + "-" + std::to_string(::getpid());
+    return who;
+}
+
+/**
+ * Set by SIGINT and SIGTERM, at which point the coordinator stops its
+ * workers and releases its claims, so that a rerun can pick them up
+ * straight away.
+ */
+volatile std::sig_atomic_t interrupted = 0;
+
+extern "C" void on_signal(int sig)
+{
+    interrupted = sig;
+}
+
+void install_signal_handlers()
+{
+    struct sigaction sa;
+    std::memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = on_signal;
+    sigemptyset(&sa.sa_mask);
+    ::sigaction(SIGINT, &sa, nullptr);
+    ::sigaction(SIGTERM, &sa, nullptr);
+}
+
+std::string read_line(const std::string& path)
+{
+    std::ifstream in{path};
+    std::string line;
+    std::getline(in, line);
+    return line;
+}
+
+bool owns(const std::string& claim)
+{
+    return read_line(claim) == owner();
+}
+
+bool create_claim(const std::string& claim)
+{
+    auto fd = ::open(claim.c_str(), O_WRONLY | O_CREAT | O_EXCL, 0644);
+    if (fd < 0)
+    {
+        if (errno != EEXIST)
+            std::cerr << "Failed to create " << claim << ": "
+                      << std::strerror(errno) << std::endl;
+        return false;
+    }
+
+    auto who = owner() + "\n";
+    if (::write(fd, who.data(), who.size()) < 0)
+        std::cerr << "Failed to write " << claim << std::endl;
+    ::close(fd);
+    return true;
+}
+
+/**
+ * Removes the claim on a shard if (and only if) it is held by `holder`.
+ * The claim is first renamed to a name private to this coordinator, which
+ * only one of several racing processes can do; if it then turns out to
+ * belong to somebody else it is linked back into place. Should yet
+ * another claim have appeared in the meantime, the owner of the one we
+ * moved notices that it lost the shard the next time it renews it.
+ */
+bool remove_claim(const std::string& claim, const std::string& holder)
+{
+    auto aside = claim + "." + owner() + ".tmp";
+    if (::rename(claim.c_str(), aside.c_str()) != 0)
+        return false;
+
+    auto held = read_line(aside) == holder;
+    if (!held)
+        ::link(aside.c_str(), claim.c_str());
+    ::unlink(aside.c_str());
+    return held;
+}
+
+void release(const std::string& claim)
+{
+    remove_claim(claim, owner());
+}
+
+/**
+ * Whether a claim is held by a coordinator on this machine that no
+ * longer exists, e.g. because it was killed with SIGKILL.
+ */
+bool held_by_dead_process(const std::string& holder)
+{
+    auto dash = holder.rfind('-');
+    if (dash == std::string::npos || holder.substr(0, dash) != hostname())
+        return false;
+
+    std::size_t pid;
+    if (!meded::parse_count(holder.substr(dash + 1), pid))
+        return false;
+    return ::kill(static_cast<pid_t>(pid), 0) != 0 && errno == ESRCH;
+}
+
+/**
+ * Attempts to take ownership of a shard, taking over the claim of a
+ * coordinator that has died or stopped renewing it.
+ */
+bool try_claim(const std::string& claim, std::time_t lease)
+{
+    if (create_claim(claim))
+        return true;
+
+    auto holder = read_line(claim);
+    struct stat st;
+    if (holder.empty() || ::stat(claim.c_str(), &st) != 0)
+        return false;
+
+    auto stale = std::time(nullptr) - st.st_mtime > lease;
+    if (!stale && !held_by_dead_process(holder))
+    {
+        // say so once per holder, rather than sitting there silently
+        static std::map<std::string, std::string> waiting;
+        if (waiting[claim] != holder)
+        {
+            std::cout << "waiting for " << claim << " held by " << holder
+                      << std::endl;
+            waiting[claim] = holder;
+        }
+        return false;
+    }
+
+    if (!remove_claim(claim, holder))
+        return false;
+
+    std::cerr << "Taking over " << (stale ? "stale" : "dead") << " claim "
+              << claim << " from " << holder << std::endl;
+    return create_claim(claim);
+}
+
+std::size_t read_count(const std::string& path)
+{
+    std::ifstream in{path};
+    std::size_t count = 0;
+    in >> count;
+    return count;
+}
+
+/**
+ * Describes the sweep that a queue directory belongs to.
+ */
+std::string manifest(const options& opts)
+{
+    std::ifstream in{opts.config, std::ios::binary};
+    if (!in)
+        return "";
+
+    // 64-bit FNV-1a, which (unlike std::hash) is the same on every machine
+    uint64_t hash = 14695981039346656037ull;
+    char c;
+    while (in.get(c))
+    {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 1099511628211ull;
+    }
+
+    std::stringstream ss;
+    ss << "executable " << opts.executable << "\n"
+       << "config " << opts.config << "\n"
+       << "config-hash " << std::hex << hash << std::dec << "\n"
+       << "shards " << opts.shards << "\n";
+    return ss.str();
+}
+
+/**
+ * Makes sure the queue directory belongs to this sweep, so that shards
+ * from an old config (or another executable, or a different number of
+ * shards) are never mixed into the results. The manifest is written to
+ * a temporary file and linked into place, so a coordinator never sees a
+ * partially written one.
+ */
+bool check_manifest(const options& opts, bool create)
+{
+    auto expected = manifest(opts);
+    if (expected.empty())
+    {
+        std::cerr << "Failed to read " << opts.config << std::endl;
+        return false;
+    }
+
+    auto path = opts.queue + "/manifest";
+    if (create)
+    {
+        auto tmp = path + "." + owner() + ".tmp";
+        std::ofstream{tmp} << expected;
+        auto created = ::link(tmp.c_str(), path.c_str()) == 0;
+        auto err = errno;
+        ::unlink(tmp.c_str());
+        if (created)
+            return true;
+        if (err != EEXIST)
+        {
+            std::cerr << "Failed to create " << path << ": "
+                      << std::strerror(err) << std::endl;
+            return false;
+        }
+    }
+
+    std::ifstream in{path};
+    std::stringstream actual;
+    actual << in.rdbuf();
+    if (!in)
+    {
+        std::cerr << "Missing " << path << std::endl;
+        return false;
+    }
+    if (actual.str() != expected)
+    {
+        std::cerr << "Queue " << opts.queue << " was made for another sweep:\n"
+                  << actual.str() << "use another --queue or remove it"
+                  << std::endl;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * A worker process started by this coordinator.
+ */
+struct worker
+{
+    std::size_t shard;
+    std::string partial;
+    bool lost;
+};
+
+/**
+ * Starts `executable config.toml` with the given extra arguments, sending
+ * its output to `log`.
+ */
+pid_t launch(const options& opts, const std::vector<std::string>& extra,
+             const std::string& log)
+{
+    std::vector<std::string> args = {opts.executable, opts.config};
+    args.insert(args.end(), extra.begin(), extra.end());
+
+    auto pid = ::fork();
+    if (pid != 0)
+        return pid;
+
+    auto fd = ::open(log.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+    if (fd >= 0)
+    {
+        ::dup2(fd, STDOUT_FILENO);
+        ::dup2(fd, STDERR_FILENO);
+        ::close(fd);
+    }
+
+    std::vector<char*> argv;
+    for (auto& arg : args)
+        argv.push_back(&arg[0]);
+    argv.push_back(nullptr);
+    ::execvp(argv[0], argv.data());
+
+    std::cerr << "Failed to run " << opts.executable << ": "
+              << std::strerror(errno) << std::endl;
+    ::_exit(127);
+}
+
+/**
+ * Makes sure the index exists before any workers start, since several
+ * workers starting at once would otherwise all try to build it. One
+ * coordinator builds it (under a claim, like a shard) and the others wait
+ * for it to finish. A failed build leaves `index.failed` in the queue
+ * directory, which has to be removed by hand to try again.
+ */
+bool prepare_index(const options& opts)
+{
+    auto claim = opts.queue + "/index.claim";
+    auto ready = opts.queue + "/index.ready";
+    auto failed = opts.queue + "/index.failed";
+    auto log = opts.queue + "/index.log";
+    while (!exists(ready))
+    {
+        if (exists(failed))
+        {
+            std::cerr << "Building the index failed; see " << log << std::endl;
+            return false;
+        }
+
+        if (interrupted)
+            return false;
+
+        if (!try_claim(claim, opts.lease))
+        {
+            ::sleep(1);
+            continue;
+        }
+
+        std::cout << "building the index" << std::endl;
+        auto pid = launch(opts, {"--index-only"}, log);
+        int status = 0;
+        while (pid > 0 && ::waitpid(pid, &status, WNOHANG) == 0)
+        {
+            if (interrupted)
+            {
+                ::kill(pid, SIGTERM);
+                ::waitpid(pid, &status, 0);
+                release(claim);
+                return false;
+            }
+            ::utime(claim.c_str(), nullptr);
+            ::sleep(1);
+        }
+
+        if (pid > 0 && WIFEXITED(status) && WEXITSTATUS(status) == 0)
+            std::ofstream{ready} << owner() << "\n";
+        else
+            std::ofstream{failed} << owner() << "\n";
+        release(claim);
+    }
+    return true;
+}
+
+/**
+ * Records the outcome of a worker and releases its claim.
+ */
+void finish(const options& opts, const worker& w, int status)
+{
+    shard_files files{opts.queue, w.shard};
+    if (interrupted)
+    {
+        // the worker was most likely stopped by the same Ctrl-C, so this
+        // doesn't count as an attempt
+        ::unlink(w.partial.c_str());
+        if (!w.lost)
+            release(files.claim);
+        return;
+    }
+
+    if (w.lost)
+    {
+        ::unlink(w.partial.c_str());
+        std::cerr << "shard " << w.shard << " stopped after losing its claim"
+                  << std::endl;
+        return;
+    }
+
+    if (WIFEXITED(status) && WEXITSTATUS(status) == 0
+        && ::rename(w.partial.c_str(), files.results.c_str()) == 0)
+    {
+        std::cout << "shard " << w.shard << " done" << std::endl;
+        release(files.claim);
+        return;
+    }
+
+    ::unlink(w.partial.c_str());
+    std::cerr << "shard " << w.shard << " failed (";
+    if (WIFSIGNALED(status))
+        std::cerr << "signal " << WTERMSIG(status);
+    else
+        std::cerr << "exit status " << WEXITSTATUS(status);
+    std::cerr << "); see " << files.log << std::endl;
+
+    // if the claim was taken over, the attempt belongs to the new owner
+    if (!owns(files.claim))
+        return;
+
+    auto attempts = read_count(files.attempts) + 1;
+    std::ofstream{files.attempts} << attempts << "\n";
+    if (attempts > opts.retries)
+        std::ofstream{files.failed} << attempts << "\n";
+    release(files.claim);
+}
+
+/**
+ * Stops every worker of an interrupted coordinator and releases their
+ * claims.
+ */
+void stop(const options& opts, std::map<pid_t, worker>& running)
+{
+    for (const auto& entry : running)
+        ::kill(entry.first, SIGTERM);
+
+    for (const auto& entry : running)
+    {
+        int status;
+        while (::waitpid(entry.first, &status, 0) < 0 && errno == EINTR)
+            continue;
+
+        const auto& w = entry.second;
+        ::unlink(w.partial.c_str());
+        if (!w.lost)
+            release(shard_files{opts.queue, w.shard}.claim);
+    }
+    running.clear();
+}
+
+/**
+ * Runs shards until every one of them has either finished or run out of
+ * retries, returning whether all of them finished.
+ */
+bool run(const options& opts)
+{
+    std::map<pid_t, worker> running;
+    std::size_t launches = 0;
+    while (true)
+    {
+        if (interrupted)
+        {
+            std::cerr << "Interrupted; stopping " << running.size()
+                      << " workers" << std::endl;
+            stop(opts, running);
+            return false;
+        }
+
+        int status;
+        pid_t pid;
+        while ((pid = ::waitpid(-1, &status, WNOHANG)) > 0)
+        {
+            auto w = running.at(pid);
+            running.erase(pid);
+            finish(opts, w, status);
+        }
+
+        // renew our claims so other coordinators don't take them over, and
+        // stop any worker whose claim was taken over anyway
+        for (auto& entry : running)
+        {
+            auto& w = entry.second;
+            shard_files files{opts.queue, w.shard};
+            if (owns(files.claim))
+            {
+                ::utime(files.claim.c_str(), nullptr);
+            }
+            else if (!w.lost)
+            {
+                std::cerr << "Lost claim " << files.claim << "; stopping pid "
+                          << entry.first << std::endl;
+                ::kill(entry.first, SIGTERM);
+                w.lost = true;
+            }
+        }
+
+        std::size_t done = 0;
+        std::size_t failed = 0;
+        for (std::size_t k = 1; k <= opts.shards; ++k)
+        {
+            shard_files files{opts.queue, k};
+            if (exists(files.results))
+            {
+                ++done;
+                continue;
+            }
+            if (exists(files.failed))
+            {
+                ++failed;
+                continue;
+            }
+
+            bool ours = false;
+            for (const auto& entry : running)
+                ours = ours || entry.second.shard == k;
+            if (ours || running.size() >= opts.jobs
+                || !try_claim(files.claim, opts.lease))
+                continue;
+
+            // another coordinator may have finished it since we looked
+            if (exists(files.results))
+            {
+                release(files.claim);
+                continue;
+            }
+
+            // a shard that ran out of retries but has no .failed file was
+            // marked for another try by hand, so start counting afresh
+            if (read_count(files.attempts) > opts.retries)
+                ::unlink(files.attempts.c_str());
+
+            // every attempt writes its own file, so that a worker orphaned
+            // by a dead coordinator can't clobber the output of its
+            // replacement
+            auto partial = files.results + "." + owner() + "."
+                           + std::to_string(++launches) + ".tmp";
+            auto shard = std::to_string(k) + "/" + std::to_string(opts.shards);
+            pid = launch(opts, {"--shard", shard, "--output", partial},
+                         files.log);
+            if (pid < 0)
+            {
+                std::cerr << "fork: " << std::strerror(errno) << std::endl;
+                release(files.claim);
+                continue;
+            }
+            std::cout << "shard " << k << " started (pid " << pid << ")"
+                      << std::endl;
+            running[pid] = {k, partial, false};
+        }
+
+        if (done + failed == opts.shards)
+        {
+            for (std::size_t k = 1; k <= opts.shards; ++k)
+                if (exists(shard_files{opts.queue, k}.failed))
+                    std::cerr << "shard " << k << " gave up after "
+                              << opts.retries + 1 << " attempts" << std::endl;
+            return failed == 0;
+        }
+
+        ::sleep(1);
+    }
+}
+
+std::vector<std::string> split(const std::string& line)
+{
+    std::vector<std::string> fields;
+    std::stringstream ss{line};
+    std::string field;
+    while (std::getline(ss, field, ','))
+        fields.push_back(field);
+    return fields;
+}
+
+/**
+ * Orders the grouping keys of the learning curves, comparing fields
+ * numerically where both of them are numbers.
+ */
+struct key_less
+{
+    bool operator()(const std::vector<std::string>& lhs,
+                    const std::vector<std::string>& rhs) const
+    {
+        for (std::size_t i = 0; i < lhs.size() && i < rhs.size(); ++i)
+        {
+            char* lend;
+            char* rend;
+            auto lval = std::strtod(lhs[i].c_str(), &lend);
+            auto rval = std::strtod(rhs[i].c_str(), &rend);
+            if (!lhs[i].empty() && !rhs[i].empty() && *lend == '\0'
+                && *rend == '\0')
+            {
+                if (lval != rval)
+                    return lval < rval;
+            }
+            else if (lhs[i] != rhs[i])
+            {
+                return lhs[i] < rhs[i];
+            }
+        }
+        return lhs.size() < rhs.size();
+    }
+};
+
+/**
+ * Moves a finished temporary file into place.
+ */
+bool replace(const std::string& tmp, const std::string& path)
+{
+    if (::rename(tmp.c_str(), path.c_str()) == 0)
+        return true;
+
+    std::cerr << "Failed to write " << path << ": " << std::strerror(errno)
+              << std::endl;
+    ::unlink(tmp.c_str());
+    return false;
+}
+
+/**
+ * Concatenates the per-shard results and aggregates them into learning
+ * curves averaged across trials.
+ */
+bool merge(const options& opts)
+{
+    std::string header;
+    std::vector<std::string> rows;
+    for (std::size_t k = 1; k <= opts.shards; ++k)
+    {
+        shard_files files{opts.queue, k};
+        std::ifstream in{files.results};
+        if (!in)
+        {
+            std::cerr << "Missing " << files.results << std::endl;
+            return false;
+        }
+
+        std::string line;
+        std::getline(in, line);
+        if (header.empty())
+            header = line;
+        if (line != header)
+        {
+            std::cerr << files.results << " has a different header"
+                      << std::endl;
+            return false;
+        }
+
+        while (std::getline(in, line))
+            if (!line.empty())
+                rows.push_back(line);
+    }
+
+    auto results_path = opts.queue + "/results.csv";
+    auto results_tmp = results_path + "." + owner() + ".tmp";
+    {
+        std::ofstream out{results_tmp};
+        out << header << "\n";
+        for (const auto& row : rows)
+            out << row << "\n";
+    }
+    if (!replace(results_tmp, results_path))
+        return false;
+    std::cout << "Wrote " << rows.size() << " rows to " << results_path
+              << std::endl;
+
+    auto columns = split(header);
+    std::size_t trial_col = columns.size();
+    std::size_t size_col = columns.size();
+    for (std::size_t i = 0; i < columns.size(); ++i)
+    {
+        if (columns[i] == "trial")
+            trial_col = i;
+        else if (columns[i] == "training-size")
+            size_col = i;
+    }
+    if (trial_col == columns.size() || size_col == columns.size())
+    {
+        std::cerr << "No trial and training-size columns; skipping curves"
+                  << std::endl;
+        return true;
+    }
+
+    struct group
+    {
+        std::size_t count = 0;
+        std::vector<double> sum;
+        std::vector<double> sum_sq;
+    };
+    std::map<std::vector<std::string>, group, key_less> curves;
+    auto num_values = columns.size() - size_col - 1;
+    for (const auto& row : rows)
+    {
+        auto fields = split(row);
+        if (fields.size() != columns.size())
+        {
+            std::cerr << "Skipping malformed row: " << row << std::endl;
+            continue;
+        }
+
+        std::vector<std::string> key;
+        for (std::size_t i = 0; i <= size_col; ++i)
+            if (i != trial_col)
+                key.push_back(fields[i]);
+
+        auto& grp = curves[key];
+        grp.sum.resize(num_values);
+        grp.sum_sq.resize(num_values);
+        ++grp.count;
+        for (std::size_t i = 0; i < num_values; ++i)
+        {
+            auto val = std::strtod(fields[size_col + 1 + i].c_str(), nullptr);
+            grp.sum[i] += val;
+            grp.sum_sq[i] += val * val;
+        }
+    }
+
+    auto curves_path = opts.queue + "/curves.csv";
+    auto curves_tmp = curves_path + "." + owner() + ".tmp";
+    {
+        std::ofstream out{curves_tmp};
+        for (std::size_t i = 0; i <= size_col; ++i)
+            if (i != trial_col)
+                out << columns[i] << ",";
+        out << "trials";
+        for (std::size_t i = size_col + 1; i < columns.size(); ++i)
+            out << "," << columns[i] << "-mean," << columns[i] << "-stddev";
+        out << "\n";
+
+        for (const auto& curve : curves)
+        {
+            for (const auto& field : curve.first)
+                out << field << ",";
+
+            const auto& grp = curve.second;
+            out << grp.count;
+            for (std::size_t i = 0; i < num_values; ++i)
+            {
+                auto mean = grp.sum[i] / grp.count;
+                auto var = grp.count > 1
+                               ? (grp.sum_sq[i] - grp.sum[i] * mean)
+                                     / (grp.count - 1)
+                               : 0.0;
+                out << "," << mean << "," << std::sqrt(std::max(var, 0.0));
+            }
+            out << "\n";
+        }
+    }
+    if (!replace(curves_tmp, curves_path))
+        return false;
+    std::cout << "Wrote " << curves.size() << " rows to " << curves_path
+              << std::endl;
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    options opts;
+    if (!parse_options(argc, argv, opts))
+    {
+        std::cerr << "Usage: " << argv[0]
+                  << " --shards N [--jobs P] [--queue dir] [--retries R]"
+                     " [--lease seconds] executable config.toml\n"
+                  << "       " << argv[0]
+                  << " --shards N [--queue dir] --merge-only executable"
+                     " config.toml"
+                  << std::endl;
+        return 1;
+    }
+
+    if (!opts.merge_only && ::mkdir(opts.queue.c_str(), 0755) != 0
+        && errno != EEXIST)
+    {
+        std::cerr << "Failed to create " << opts.queue << ": "
+                  << std::strerror(errno) << std::endl;
+        return 1;
+    }
+
+    if (!check_manifest(opts, !opts.merge_only))
+        return 1;
+
+    install_signal_handlers();
+    if (!opts.merge_only && (!prepare_index(opts) || !run(opts)))
+        return 1;
+
+    return merge(opts) ? 0 : 1;
+}
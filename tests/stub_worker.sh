@@ -0,0 +1,22 @@
+#!/bin/sh
+# Stands in for active-l2r in the sweep-coordinator test. The "config"
+# file lists shards that should fail ("fail-once k" or "fail-always k");
+# every other shard k writes trial k - 1 of the same grid cell.
+
+config=$1
+[ "$2" = "--index-only" ] && exit 0
+k=${3%/*}
+out=$5
+queue=$(dirname "$out")
+
+grep -qx "fail-always $k" "$config" && exit 1
+if grep -qx "fail-once $k" "$config" && [ ! -e "$queue/shard-$k.crashed" ]
+then
+    touch "$queue/shard-$k.crashed"
+    exit 1
+fi
+
+echo "trial,strategy,num-seeds,max-train-size,training-size,num-distinct,NDPM" \
+    > "$out"
+echo "$((k - 1)),uncertainty,10,150,10,5,0.$k" >> "$out"
+echo "$((k - 1)),uncertainty,10,150,11,5,$k" >> "$out"
@@ -0,0 +1,55 @@
+#!/bin/sh
+# Runs sweep-coordinator against stub_worker.sh and checks its retries,
+# its handling of shards that never succeed, and the merged curves.
+#
+# Usage: sweep_coordinator_test.sh sweep-coordinator stub_worker.sh
+
+coord=$1
+worker=$2
+dir=$(mktemp -d)
+trap 'rm -rf "$dir"' EXIT
+cd "$dir" || exit 1
+
+fail()
+{
+    echo "FAIL: $*"
+    exit 1
+}
+
+# shard 2 fails once and is retried; the three trials are then averaged
+echo "fail-once 2" > retry.toml
+"$coord" --shards 3 --jobs 2 --queue retry "$worker" retry.toml \
+    || fail "sweep with a retried shard did not succeed"
+[ "$(cat retry/shard-2.attempts)" = 1 ] || fail "shard 2 was not retried"
+[ "$(wc -l < retry/results.csv)" -eq 7 ] || fail "results.csv is incomplete"
+
+cat > expected.csv <<'CSV'
+strategy,num-seeds,max-train-size,training-size,trials,num-distinct-mean,num-distinct-stddev,NDPM-mean,NDPM-stddev
+uncertainty,10,150,10,3,5,0,0.2,0.1
+uncertainty,10,150,11,3,5,0,2,1
+CSV
+diff expected.csv retry/curves.csv || fail "curves.csv is wrong"
+
+# the queue belongs to the sweep it was made for
+echo "fail-once 3" > other.toml
+"$coord" --shards 3 --queue retry "$worker" other.toml \
+    && fail "queue was reused with a different config"
+"$coord" --shards 2 --queue retry --merge-only "$worker" retry.toml \
+    && fail "queue was merged with a different number of shards"
+
+# shard 1 never succeeds, so it is given up on after --retries
+echo "fail-always 1" > broken.toml
+"$coord" --shards 2 --retries 1 --queue broken "$worker" broken.toml \
+    && fail "sweep with a broken shard succeeded"
+[ -e broken/shard-1.failed ] || fail "shard 1 was not marked as failed"
+[ "$(cat broken/shard-1.attempts)" = 2 ] || fail "shard 1 was not retried"
+[ -e broken/shard-2.csv ] || fail "shard 2 did not run"
+[ ! -e broken/results.csv ] || fail "a failed sweep was merged"
+
+# removing .failed by hand gives the shard a fresh set of retries
+rm broken/shard-1.failed
+"$coord" --shards 2 --retries 1 --queue broken "$worker" broken.toml \
+    && fail "rerun of a broken shard succeeded"
+[ "$(cat broken/shard-1.attempts)" = 2 ] || fail "retries were not reset"
+
+echo "PASS"
@@ -0,0 +1,134 @@
+/**
+ * @file sweep_test.cpp
+ *
+ * Checks the command line handling and the reading of the sweep from the
+ * config file that the active learning executables share in sweep.h.
+ */
+
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "sweep.h"
+
+using namespace meded;
+
+static int failures = 0;
+
+#define CHECK(cond)                                                            \
+    do                                                                         \
+    {                                                                          \
+        if (!(cond))                                                           \
+        {                                                                      \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": " #cond             \
+                      << std::endl;                                            \
+            ++failures;                                                        \
+        }                                                                      \
+    } while (0)
+
+std::shared_ptr<cpptoml::table> parse_config(const std::string& text)
+{
+    std::istringstream in{text};
+    cpptoml::parser parser{in};
+    return parser.parse();
+}
+
+meta::util::optional<command_line> parse(std::vector<std::string> args)
+{
+    args.insert(args.begin(), "active-l2r");
+    std::vector<char*> argv;
+    for (auto& arg : args)
+        argv.push_back(&arg[0]);
+    return parse_command_line(static_cast<int>(argv.size()), argv.data(),
+                              "results.csv");
+}
+
+int main()
+{
+    // shard specifications
+    auto shard = parse_shard("2/3");
+    CHECK(shard && shard->index == 2 && shard->count == 3);
+    CHECK(parse_shard("3/3"));
+    CHECK(parse_shard("1/1"));
+    CHECK(!parse_shard("0/3"));
+    CHECK(!parse_shard("4/3"));
+    CHECK(!parse_shard("1/"));
+    CHECK(!parse_shard("/3"));
+    CHECK(!parse_shard("1/0"));
+    CHECK(!parse_shard("3"));
+    CHECK(!parse_shard("-1/3"));
+    CHECK(!parse_shard("a/b"));
+    CHECK(!parse_shard("99999999999999999999/1"));
+
+    // every cell belongs to exactly one shard
+    for (std::size_t cell = 0; cell < 10; ++cell)
+    {
+        int owners = 0;
+        for (std::size_t k = 1; k <= 3; ++k)
+            owners += parse_shard(std::to_string(k) + "/3")->contains(cell);
+        CHECK(owners == 1);
+    }
+
+    // command lines
+    auto cmd = parse({"config.toml"});
+    CHECK(cmd && cmd->config == "config.toml" && cmd->output == "results.csv");
+    CHECK(cmd && cmd->shard.count == 1 && !cmd->index_only);
+
+    cmd = parse({"config.toml", "--shard", "2/3"});
+    CHECK(cmd && cmd->output == "results-2-of-3.csv");
+
+    cmd = parse({"config.toml", "--shard", "1/1"});
+    CHECK(cmd && cmd->output == "results.csv");
+
+    cmd = parse({"config.toml", "--shard", "2/3", "--output", "out.csv"});
+    CHECK(cmd && cmd->output == "out.csv" && cmd->shard.index == 2);
+
+    cmd = parse({"config.toml", "--index-only"});
+    CHECK(cmd && cmd->index_only);
+
+    CHECK(!parse({}));
+    CHECK(!parse({"config.toml", "--shard"}));
+    CHECK(!parse({"config.toml", "--shard", "0/3"}));
+    CHECK(!parse({"config.toml", "--output"}));
+    CHECK(!parse({"config.toml", "--bogus", "1"}));
+
+    // sweep axes may be scalars or arrays, and fall back to their defaults
+    auto config = parse_config("num-seeds = [5, 10, 20]\n"
+                               "max-train-size = 150\n"
+                               "strategy = [\"uncertainty\", \"random\"]\n"
+                               "empty = []\n"
+                               "seed = 3\n");
+    CHECK((sweep_axis<int64_t>(*config, "num-seeds", 1)
+           == std::vector<int64_t>{5, 10, 20}));
+    CHECK((sweep_axis<int64_t>(*config, "max-train-size", 1000)
+           == std::vector<int64_t>{150}));
+    CHECK((sweep_axis<int64_t>(*config, "missing", 1000)
+           == std::vector<int64_t>{1000}));
+    CHECK((sweep_axis<std::string>(*config, "strategy", "random")
+           == std::vector<std::string>{"uncertainty", "random"}));
+    CHECK((sweep_axis<std::string>(*config, "missing", "random")
+           == std::vector<std::string>{"random"}));
+    CHECK(sweep_axis<int64_t>(*config, "empty", 1).empty());
+
+    // empty or non-positive axes are rejected
+    CHECK(check_axis("num-seeds", sweep_axis<int64_t>(*config, "num-seeds", 1),
+                     1));
+    CHECK(!check_axis("empty", sweep_axis<int64_t>(*config, "empty", 1), 1));
+    CHECK(!check_axis("trials", std::vector<int64_t>{0}, 1));
+    CHECK(!check_axis("max-train-size", std::vector<int64_t>{10, -1}, 1));
+    CHECK(!check_axis("strategy", std::vector<std::string>{}));
+
+    // every process agrees on the seed for a trial, and trials differ
+    auto same = parse_config("seed = 3\n");
+    CHECK(trial_seed(*config, 0) == 3);
+    CHECK(trial_seed(*config, 2) == trial_seed(*same, 2));
+    CHECK(trial_seed(*config, 1) != trial_seed(*config, 2));
+    auto unseeded = parse_config("");
+    CHECK(trial_seed(*unseeded, 1) == trial_seed(*parse_config(""), 1));
+
+    if (failures == 0)
+        std::cout << "PASS" << std::endl;
+    return failures == 0 ? 0 : 1;
+}